@@ -0,0 +1,322 @@
+// Last edited 17/10/2026
+// Author: Anya Elvin
+// Shared definitions of the 1e1gam selection cuts, so every macro applies exactly the same cuts
+    // Cut 1: 1 electron only and 1 photon only and nothing else
+    // Cut 2: electron and gamma OM number ≤ 519
+    // Cut 3: Electron start vertices away from edges/foil
+    // Cut 4: Timing cut: measured dt is within a threshold window of dt_exp
+    // Cut 5: E_e > 50keV and E_gam > 50keV
+    // Cut 6: E_e + E_gam ≤ 3.00MeV
+// Each cut can be evaluated on its own (it checks the vectors it needs are filled, and fails the event if not),
+// so the same functions work for the chained selection in cuts_V2.C and the isolated/N-1 tables in cutflow_V2.C
+// Included by cut_macros/run_cuts_V2.h (and so cuts_V2.C and batch_cuts_V2.C), cut_macros/cutflow_V2.C and cut_macros/threshold_scan.C
+
+#ifndef CUTS_V2_H
+#define CUTS_V2_H
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <TTree.h>
+#include <TBranch.h>
+#include "timing_kernel.h"
+#include "om_geometry.h"
+
+const int n_cuts = 6;
+
+// Constants (c_mm_per_ns and m_e_MeV are in timing_kernel.h, no one-letter names here since every macro includes this file)
+const int e_idx = 0;
+const int g_idx = 1;
+
+// Thresholds to change
+struct CutThresholds {
+    double min_E = 0.05; // MeV
+    double max_E_tot = 3.00; // MeV
+    double y_max_pos = 2494;
+    double y_max_neg = -2494;
+    double x_max_pos = 436;
+    double x_max_neg = -436;
+    double x_calo_buffer = 100.0; // mm
+    double x_foil_buffer = 60.0; // mm
+    double y_buffer = 30.0; // mm
+    double t_threshold = 0.05331; // ns/mm
+    // Not a threshold: take the gamma's OM centre from om_geometry.h by om_number, so gamma_om_y/z are never read
+    // (and are left out of full copies of the survivors). gamma_om_x is still read, cut 2 needs it to be filled
+    // Check the table first with cut_macros/om_geometry_check.C
+    bool om_geometry_table = false;
+};
+
+// Numbers from one pass of the selection over a file, so nothing has to reopen the output to count entries
+struct SelectionResult {
+    bool ok = false;
+    Long64_t N_orig = 0;
+    Long64_t pass_cut[n_cuts] = {0}; // number surviving cuts 1 to k+1
+    const char* cache = "none"; // what selection_cache.C did: "none" (not used), "miss", "partial" or "hit"
+    Long64_t N_cut() const { return pass_cut[n_cuts - 1]; }
+};
+
+// Branches of Result_tree used by the cuts
+struct ResultTreeEvent {
+    Int_t electron_number = 0, gamma_number = 0;
+    std::vector<double>* energy = nullptr;
+    std::vector<double>* first_vertex_x = nullptr;
+    std::vector<double>* first_vertex_y = nullptr;
+    std::vector<double>* first_vertex_z = nullptr;
+    std::vector<double>* second_vertex_x = nullptr;
+    std::vector<double>* second_vertex_y = nullptr;
+    std::vector<double>* second_vertex_z = nullptr;
+    std::vector<int>* om_number = nullptr;
+    std::vector<double>* calo_tdc = nullptr;
+    std::vector<double>* gamma_om_x = nullptr;
+    std::vector<double>* gamma_om_y = nullptr;
+    std::vector<double>* gamma_om_z = nullptr;
+    bool om_geometry_table = false; // gamma_om_y/z are not read, the gamma's OM centre comes from om_geometry.h
+
+    // With omGeometryTable the gamma_om_y/z branches are switched off, so nothing reads (or copies) them
+    void SetBranchAddresses(TTree* tree, bool omGeometryTable = false) {
+        om_geometry_table = omGeometryTable;
+        tree->SetBranchAddress("electron_number", &electron_number);
+        tree->SetBranchAddress("gamma_number", &gamma_number);
+        tree->SetBranchAddress("energy", &energy);
+        tree->SetBranchAddress("first_vertex_x", &first_vertex_x);
+        tree->SetBranchAddress("first_vertex_y", &first_vertex_y);
+        tree->SetBranchAddress("first_vertex_z", &first_vertex_z);
+        tree->SetBranchAddress("second_vertex_x", &second_vertex_x);
+        tree->SetBranchAddress("second_vertex_y", &second_vertex_y);
+        tree->SetBranchAddress("second_vertex_z", &second_vertex_z);
+        tree->SetBranchAddress("om_number", &om_number);
+        tree->SetBranchAddress("calo_tdc", &calo_tdc);
+        tree->SetBranchAddress("gamma_om_x", &gamma_om_x);
+        const char* gamma_om_branches[2] = {"gamma_om_y", "gamma_om_z"};
+        std::vector<double>** gamma_om[2] = {&gamma_om_y, &gamma_om_z};
+        for (int b = 0; b < 2; ++b) {
+            if (om_geometry_table) tree->SetBranchStatus(gamma_om_branches[b], 0);
+            else tree->SetBranchAddress(gamma_om_branches[b], gamma_om[b]);
+        }
+    }
+};
+
+// One branch of Result_tree that can be loaded on its own, with a tally of what has been read from it
+struct StagedBranch {
+    const char* name = nullptr;
+    TBranch* branch = nullptr;
+    Long64_t loaded_entry = -1; // entry currently unpacked into the branch address
+    Long64_t entries_read = 0;
+    Long64_t bytes_read = 0; // unpacked bytes
+    Long64_t baskets_read = 0;
+    Long64_t zip_bytes_read = 0; // compressed bytes of the baskets read
+    Int_t last_basket = -1;
+
+    // Unpack the given entry into the branch address, unless it is already there (or the branch is switched off)
+    void Load(Long64_t entry, Long64_t localEntry) {
+        if (!branch || loaded_entry == entry) return;
+        bytes_read += branch->GetEntry(localEntry);
+        entries_read++;
+        loaded_entry = entry;
+        // Count a new basket every time the branch moves onto a different one
+        Int_t basket = branch->GetReadBasket();
+        if (basket != last_basket) {
+            baskets_read++;
+            if (basket >= 0) zip_bytes_read += branch->GetBasketBytes()[basket];
+            last_basket = basket;
+        }
+    }
+};
+
+// Staged reading of Result_tree: each cut only loads the branches it needs, and only for events that passed the earlier cuts
+// Branches needed by each stage of the selection, in the order the cuts use them
+    // Stage 1 (cut 1): electron_number, gamma_number
+    // Stage 2 (cut 2): gamma_om_x, om_number
+    // Stage 3 (cut 3): first_vertex_x, first_vertex_y
+    // Stage 4 (cuts 4-6): everything else
+// With staged = false every stage loads all 14 of these branches (not the same as tree->GetEntry(i): any other branch of
+// Result_tree is never loaded here, SelectionWriter reads those for the survivors it copies)
+// Branches switched off with SetBranchStatus (ie. gamma_om_y/z with the OM geometry table) are never loaded
+// The tree can be a TChain, the branches are picked up again whenever it moves onto the next file
+const int n_cut_branches = 14;
+const char* const cut_branch_names[n_cut_branches] = {"electron_number", "gamma_number",
+                                                      "gamma_om_x", "om_number",
+                                                      "first_vertex_x", "first_vertex_y",
+                                                      "calo_tdc", "energy", "first_vertex_z", "second_vertex_x", "second_vertex_y", "second_vertex_z", "gamma_om_y", "gamma_om_z"};
+
+// True if name is one of the branches the cuts read
+inline bool is_cut_branch(const char* name) {
+    for (const char* cut_branch : cut_branch_names) {
+        if (std::strcmp(name, cut_branch) == 0) return true;
+    }
+    return false;
+}
+
+struct StagedResultTree {
+    static const int n_branches = n_cut_branches;
+    const char* const* branch_names = cut_branch_names;
+    int stage_end[4] = {2, 4, 6, n_branches}; // stage s needs branch_names[0] to branch_names[stage_end[s-1] - 1]
+    StagedBranch branches[n_branches];
+    TTree* tree = nullptr;
+    bool staged = true;
+    Int_t tree_number = -1;
+    Long64_t entry = -1, localEntry = -1;
+
+    bool Setup(TTree* t, bool stagedReading) {
+        tree = t;
+        staged = stagedReading;
+        for (int b = 0; b < n_branches; ++b) branches[b].name = branch_names[b];
+        tree_number = -1;
+        return tree->LoadTree(0) >= 0 ? FindBranches() : true; // nothing to find in an empty tree
+    }
+
+    bool FindBranches() {
+        tree_number = tree->GetTreeNumber();
+        for (int b = 0; b < n_branches; ++b) {
+            branches[b].last_basket = -1;
+            if (!tree->GetBranchStatus(branch_names[b])) {
+                branches[b].branch = nullptr;
+                continue;
+            }
+            branches[b].branch = tree->GetBranch(branch_names[b]);
+            if (!branches[b].branch) {
+                std::cerr << "Error: Cannot find branch '" << branch_names[b] << "' in Result_tree." << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Move onto entry i, nothing is unpacked until LoadStage is called
+    bool SetEntry(Long64_t i) {
+        entry = i;
+        localEntry = tree->LoadTree(i);
+        if (localEntry < 0) return false;
+        if (tree->GetTreeNumber() != tree_number) return FindBranches();
+        return true;
+    }
+
+    // Loads the branches of stages 1..stage for the current entry (all of them when not staged)
+    void LoadStage(int stage) {
+        int end = staged ? stage_end[stage - 1] : n_branches;
+        for (int b = 0; b < end; ++b) branches[b].Load(entry, localEntry);
+    }
+
+    void PrintReport() const {
+        std::cout << "\nBranch read summary (" << (staged ? "staged" : "full") << " reading):" << std::endl;
+        std::cout << "branch | entries_read | bytes_read | baskets_read | zip_bytes_read" << std::endl;
+        Long64_t total_bytes = 0, total_baskets = 0, total_zip_bytes = 0;
+        for (int b = 0; b < n_branches; ++b) {
+            std::cout << branches[b].name << " | " << branches[b].entries_read << " | " << branches[b].bytes_read << " | "
+                      << branches[b].baskets_read << " | " << branches[b].zip_bytes_read << std::endl;
+            total_bytes += branches[b].bytes_read;
+            total_baskets += branches[b].baskets_read;
+            total_zip_bytes += branches[b].zip_bytes_read;
+        }
+        std::cout << "total | - | " << total_bytes << " | " << total_baskets << " | " << total_zip_bytes << std::endl;
+    }
+};
+
+// CUT 1: 1 electron only and and 1 photon only and nothing else
+inline bool passes_cut1(const ResultTreeEvent& ev) {
+    return ev.electron_number == 1 && ev.gamma_number == 1;
+}
+
+// CUT 2: gamma and electron OM number ≤ 519
+inline bool passes_cut2(const ResultTreeEvent& ev) {
+    if (ev.gamma_om_x->empty()) return false; // if there is no entries, skip
+    if (ev.om_number->size() < 2) return false;
+    if (ev.om_number->at(0) > 519) return false;
+    if (ev.om_number->at(1) > 519) return false;
+    return true;
+}
+
+// CUT 3: avoid electron start vertices in buffer zones
+inline bool passes_cut3(const ResultTreeEvent& ev, const CutThresholds& thr) {
+    if (ev.first_vertex_x->empty() || ev.first_vertex_y->empty()) return false;
+    double x = ev.first_vertex_x->at(e_idx);
+    double y = ev.first_vertex_y->at(e_idx);
+    // Dodge x buffer zones
+    if (x > -1*thr.x_foil_buffer && x < thr.x_foil_buffer) return false;
+    if (x > thr.x_max_pos - thr.x_calo_buffer || x < thr.x_max_neg + thr.x_calo_buffer) return false;
+    // Dodge y buffer zones
+    if (y > thr.y_max_pos - thr.y_buffer || y < thr.y_max_neg + thr.y_buffer) return false;
+    return true;
+}
+
+// Everything the timing cut needs for this event, taken from the branches (the gamma's OM centre from om_geometry.h
+// instead, if ev was set up with the OM geometry table)
+// Returns false if the branches it needs are not filled
+inline bool get_timing_inputs(const ResultTreeEvent& ev, TimingInputs& in) {
+    if (ev.calo_tdc->size() < 2) return false; // check first cut worked
+    if (ev.energy->empty() || ev.first_vertex_x->empty() || ev.second_vertex_x->empty()) return false;
+    if (ev.gamma_om_x->empty()) return false;
+    if (ev.om_geometry_table) {
+        if (ev.om_number->size() < 2 || !om_centre(ev.om_number->at(g_idx), in.xg, in.yg, in.zg)) return false;
+    } else {
+        in.xg = ev.gamma_om_x->at(e_idx);
+        in.yg = ev.gamma_om_y->at(e_idx);
+        in.zg = ev.gamma_om_z->at(e_idx);
+    }
+    in.t_e_meas = ev.calo_tdc->at(e_idx);
+    in.t_g_meas = ev.calo_tdc->at(g_idx);
+    in.T_e = ev.energy->at(e_idx);
+    in.x1 = ev.first_vertex_x->at(e_idx);
+    in.y1 = ev.first_vertex_y->at(e_idx);
+    in.z1 = ev.first_vertex_z->at(e_idx);
+    in.x2 = ev.second_vertex_x->at(e_idx);
+    in.y2 = ev.second_vertex_y->at(e_idx);
+    in.z2 = ev.second_vertex_z->at(e_idx);
+    return true;
+}
+
+// CUT 4: timing cut (the calculation itself is timing_quantities_scalar in timing_kernel.h)
+// If timing is given, it is filled with the quantities worked out on the way (when the event gets that far)
+inline bool passes_cut4(const ResultTreeEvent& ev, const CutThresholds& thr, TimingQuantities* timing = nullptr) {
+    TimingInputs in;
+    if (!get_timing_inputs(ev, in)) return false;
+    TimingQuantities q;
+    if (!timing_quantities_scalar(in, q)) return false;
+    if (timing) *timing = q;
+    if (q.normalised_diff > thr.t_threshold) return false; // reject event
+    return true;
+}
+
+// CUT 5: electron energy > 50keV and photon energy > 50keV
+inline bool passes_cut5(const ResultTreeEvent& ev, const CutThresholds& thr) {
+    if (ev.energy->size() < 2) return false; // check first cut worked
+    double electron_energy = ev.energy->at(e_idx);
+    double gamma_energy = ev.energy->at(g_idx);
+    if (electron_energy < thr.min_E || gamma_energy < thr.min_E) return false;
+    return true;
+}
+
+// CUT 6: total energy ≤ 3.00 MeV
+inline bool passes_cut6(const ResultTreeEvent& ev, const CutThresholds& thr) {
+    if (ev.energy->size() < 2) return false;
+    double E_tot = ev.energy->at(e_idx) + ev.energy->at(g_idx);
+    if (E_tot > thr.max_E_tot) return false;
+    return true;
+}
+
+// Evaluates cut number 1-6 on its own
+inline bool passes_cut(int cut, const ResultTreeEvent& ev, const CutThresholds& thr, TimingQuantities* timing = nullptr) {
+    switch (cut) {
+        case 1: return passes_cut1(ev);
+        case 2: return passes_cut2(ev);
+        case 3: return passes_cut3(ev, thr);
+        case 4: return passes_cut4(ev, thr, timing);
+        case 5: return passes_cut5(ev, thr);
+        case 6: return passes_cut6(ev, thr);
+    }
+    return false;
+}
+
+// Applies cuts first_cut to 6 in order to the current entry of reader, loading each stage only when it is needed
+// Returns how many cuts the event passes in a row, counting cuts before first_cut as passed
+inline int apply_cuts_from(int first_cut, const ResultTreeEvent& ev, const CutThresholds& thr, StagedResultTree& reader) {
+    const int stage_of_cut[n_cuts] = {1, 2, 3, 4, 4, 4};
+    for (int cut = first_cut; cut <= n_cuts; ++cut) {
+        reader.LoadStage(stage_of_cut[cut - 1]);
+        if (!passes_cut(cut, ev, thr)) return cut - 1;
+    }
+    return n_cuts;
+}
+
+#endif
@@ -0,0 +1,75 @@
+// Last edited 17/10/2026
+// Author: Anya Elvin
+// Centres of the main wall optical modules (OMs), worked out at compile time and looked up by om_number
+// Cut 2 only keeps events whose OMs are on the main walls (om_number ≤ 519), so for the timing cut the gamma's OM is
+// always one of these 520, and its centre can come from this table instead of the gamma_om_y/z branches (gamma_om_x is
+// still read, since cut 2 rejects events where it is empty)
+// Main wall numbering: om_number = side * 260 + column * 13 + row
+    // side 0 at negative x, side 1 at positive x (front faces at x = ±om_x_front)
+    // 20 columns along y, om_y_pitch apart, centred on y = 0
+    // 13 rows along z, om_z_pitch apart, centred on z = 0
+// These are the nominal positions: check them against real files with cut_macros/om_geometry_check.C before trusting
+// the table for a new data set (and change the constants here if it finds any differences)
+// Used by cut_macros/cuts_V2.h (CutThresholds::om_geometry_table), cut_macros/synthetic_result_tree.h and cut_macros/om_geometry_check.C
+
+#ifndef OM_GEOMETRY_H
+#define OM_GEOMETRY_H
+
+#include <cmath>
+#include <algorithm>
+
+const int n_main_wall_oms = 520;
+const int n_om_columns = 20;
+const int n_om_rows = 13;
+constexpr double om_x_front = 435.0; // mm
+constexpr double om_y_pitch = 259.0; // mm
+constexpr double om_z_pitch = 256.0; // mm
+
+struct OMCentre {
+    double x = 0, y = 0, z = 0;
+};
+
+// Centre of main wall OM om (0-519), mm
+constexpr OMCentre main_wall_om_centre(int om) {
+    OMCentre centre;
+    int side = om / (n_om_columns * n_om_rows);
+    int column = (om % (n_om_columns * n_om_rows)) / n_om_rows;
+    int row = om % n_om_rows;
+    centre.x = side == 0 ? -om_x_front : om_x_front;
+    centre.y = (column - 0.5 * (n_om_columns - 1)) * om_y_pitch;
+    centre.z = (row - 0.5 * (n_om_rows - 1)) * om_z_pitch;
+    return centre;
+}
+
+struct OMTable {
+    OMCentre centre[n_main_wall_oms];
+};
+
+constexpr OMTable make_om_table() {
+    OMTable table;
+    for (int om = 0; om < n_main_wall_oms; ++om) table.centre[om] = main_wall_om_centre(om);
+    return table;
+}
+
+// The table itself, filled in by the compiler
+constexpr OMTable om_table = make_om_table();
+
+// Looks up the centre of OM om, returns false if it is not on the main walls
+inline bool om_centre(int om, double& x, double& y, double& z) {
+    if (om < 0 || om >= n_main_wall_oms) return false;
+    x = om_table.centre[om].x;
+    y = om_table.centre[om].y;
+    z = om_table.centre[om].z;
+    return true;
+}
+
+// Main wall OM whose centre is closest to (y, z) on the given side
+inline int nearest_main_wall_om(int side, double y, double z) {
+    int column = (int) std::lround(y / om_y_pitch + 0.5 * (n_om_columns - 1));
+    int row = (int) std::lround(z / om_z_pitch + 0.5 * (n_om_rows - 1));
+    column = std::min(std::max(column, 0), n_om_columns - 1);
+    row = std::min(std::max(row, 0), n_om_rows - 1);
+    return side * n_om_columns * n_om_rows + column * n_om_rows + row;
+}
+
+#endif
@@ -0,0 +1,119 @@
+// Last edited 17/10/2026
+// Author: Anya Elvin
+// The 1e1gam selection loop over one file (see cuts_V2.C for the cuts, the staged reading and the output modes)
+// run_cuts_V2 returns the numbers surviving each cut, it is used by cut_macros/cuts_V2.C, cut_macros/batch_cuts_V2.C
+// and benchmarks/selection_benchmark.C
+
+#ifndef RUN_CUTS_V2_H
+#define RUN_CUTS_V2_H
+
+#include <iostream>
+#include <TFile.h>
+#include <TTree.h>
+#include "cuts_V2.h"
+#include "selection_output.h"
+
+inline SelectionResult run_cuts_V2(const char* inputFileName, const char* outputFileName, const CutThresholds& thresholds, bool staged = true, bool verbose = true,
+                                   const OutputOptions& outputOptions = OutputOptions()) {
+    SelectionResult result;
+    // Load the dataset 
+    TFile *inputFile = TFile::Open(inputFileName, "READ");
+    if (!inputFile || inputFile->IsZombie()) {
+        std::cerr << "Error: Cannot open input file " << inputFileName << std::endl;
+        delete inputFile;
+        return result;
+    }
+    TTree *tree = (TTree*) inputFile->Get("Result_tree");
+    if (!tree) {
+        std::cerr << "Error: Cannot find TTree 'Result_tree' in file " << inputFileName << std::endl;
+        delete inputFile;
+        return result;
+    }
+
+    // Set up branches
+    ResultTreeEvent event;
+    event.SetBranchAddresses(tree, thresholds.om_geometry_table);
+
+    // Staged reading of the branches (see StagedResultTree in cuts_V2.h)
+    StagedResultTree reader;
+    if (!reader.Setup(tree, staged)) {
+        delete inputFile;
+        return result;
+    }
+
+    // Begin the process of preparing to sort through the data
+    // Setup counters
+    Long64_t pass_cut1 = 0, pass_cut2 = 0, pass_cut3 = 0, pass_cut4 = 0, pass_cut5 = 0, pass_cut6 = 0; // number surviving each cut
+    Long64_t surviving_electrons = 0, surviving_gammas = 0; // remaining particles of each type after all cuts have been applied
+
+    // Prepare output file to store cut data in
+    SelectionWriter writer;
+    if (!writer.Open(outputFileName, tree, outputOptions)) {
+        delete inputFile;
+        return result;
+    }
+
+    // Now we can start sorting through the data and cutting it
+    // Loop through events in Result_tree
+    Long64_t nEntries = tree->GetEntries();
+    if (verbose) {
+        std::cout << "\nStarting to loop through simulation file " << std::endl;
+        std::cout << "Number of events: " << nEntries << std::endl;
+    }
+    for (Long64_t i = 0; i < nEntries; ++i) {
+        reader.SetEntry(i);
+        reader.LoadStage(1);
+
+        // CUT 1: 1 electron only and and 1 photon only and nothing else 
+        if (!passes_cut1(event)) continue;
+        pass_cut1++;
+
+        // CUT 2: gamma and electron OM number ≤ 519
+        reader.LoadStage(2);
+        if (!passes_cut2(event)) continue;
+        pass_cut2++;
+
+        // CUT 3: avoid electron start vertices in buffer zones
+        reader.LoadStage(3);
+        if (!passes_cut3(event, thresholds)) continue;
+        pass_cut3++;
+
+        // CUT 4: timing cut
+        reader.LoadStage(4);
+        if (!passes_cut4(event, thresholds)) continue;
+        pass_cut4++;
+
+        // CUT 5: electron energy > 50keV and photon energy > 50keV
+        if (!passes_cut5(event, thresholds)) continue;
+        pass_cut5++;
+
+        // CUT 6: total energy ≤ 3.00 MeV
+        if (!passes_cut6(event, thresholds)) continue;
+        pass_cut6++;
+
+        // END OF CUTS: count remaining particles
+        surviving_electrons += event.electron_number;
+        surviving_gammas += event.gamma_number;
+
+        // Populate the cut dataset with remaining events
+        writer.Fill(i, event);
+    }
+
+    result.ok = true;
+    result.N_orig = nEntries;
+    Long64_t pass_cut[n_cuts] = {pass_cut1, pass_cut2, pass_cut3, pass_cut4, pass_cut5, pass_cut6};
+    for (int k = 0; k < n_cuts; ++k) result.pass_cut[k] = pass_cut[k];
+
+    writer.Close(result);
+    inputFile->Close();
+    delete inputFile;
+
+    if (verbose) {
+        std::cout << "\nSaved reduced dataset (" << output_mode_names[outputOptions.mode] << ") to " << outputFileName << std::endl;
+        // I/O report: how much of each branch was actually read
+        reader.PrintReport();
+    }
+    return result;
+}
+
+#endif
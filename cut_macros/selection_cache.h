@@ -0,0 +1,333 @@
+// Last edited 17/10/2026
+// Author: Anya Elvin
+// Persistent per-run cache of the 1e1gam selection, so re-processing only redoes the runs and cuts that actually changed
+// For each input file the cache holds, for every event that passed cut 1:
+    // entry: its entry number in Result_tree
+    // cut_mask: bit k set = passed cuts 1 to k+1 (the cuts are applied in order, so the set bits always start at bit 0)
+// along with what the cache is valid for ("cache_info"): the input's size and modification time, a hash of
+// the contents of cuts_V2.h, timing_kernel.h and om_geometry.h (so any edit to what a cut does is picked up), the thresholds it was made with, and a hash of the output mode (selection_output.h)
+// When a run is processed again:
+    // input file or cut definition changed (or no cache): the whole tree is cut again ("miss")
+    // same file, same cuts, same thresholds and the output file still holds the counts and output mode of this
+    // selection (SelectionWriter::Close stores them): nothing is read at all ("hit")
+    // only the output mode changed: only the cached survivors are read again, to write them out the new way
+    // only thresholds changed: cut 1 and 2 have no thresholds, so only the cached events that got as far as the first
+    // changed cut are read again, from that cut onwards ("partial"). Tightening a threshold therefore only re-checks
+    // the cached survivors of the cuts before it, and nothing ever goes back to the full tree
+// The cut file is only rewritten when the survivors are re-evaluated
+// Used by cut_macros/selection_cache.C and cut_macros/batch_cuts_V2.C (cacheDirectory argument)
+
+#ifndef SELECTION_CACHE_H
+#define SELECTION_CACHE_H
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <TFile.h>
+#include <TTree.h>
+#include <TSystem.h>
+#include <TNamed.h>
+#include <TParameter.h>
+#include "cuts_V2.h"
+#include "selection_output.h"
+#include "run_cuts_V2.h"
+
+// What a cache file is valid for
+struct SelectionCacheInfo {
+    Long64_t file_size = -1;
+    Long64_t file_mtime = -1;
+    ULong64_t definition_hash = 0;
+    ULong64_t output_hash = 0;
+    Long64_t N_orig = 0;
+    CutThresholds thresholds;
+};
+
+// FNV-1a hash, so it is the same from one ROOT version or machine to the next
+// hash: where to start from, to carry on the hash of something before
+inline ULong64_t fnv1a_hash(const char* data, size_t size, ULong64_t hash = 14695981039346656037ULL) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (unsigned char) data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline ULong64_t string_hash(const char* text) {
+    return fnv1a_hash(text, std::strlen(text));
+}
+
+// Files that define what the cuts do, in the same directory as this one
+const char* const cut_definition_files[] = {"cuts_V2.h", "timing_kernel.h", "om_geometry.h"};
+
+// Hash of the cut definition: the contents of cut_definition_files, one after the other
+// Returns false (with a message) if one of them cannot be read, then the cache cannot be trusted
+inline bool cut_definition_hash(ULong64_t& hash) {
+    std::string directory = __FILE__;
+    size_t slash = directory.rfind('/');
+    directory = slash == std::string::npos ? "." : directory.substr(0, slash);
+    hash = fnv1a_hash("", 0);
+    for (const char* name : cut_definition_files) {
+        std::string path = directory + "/" + name;
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (!file) {
+            std::cerr << "Warning: Cannot read " << path << " to check the selection cache against" << std::endl;
+            return false;
+        }
+        std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        hash = fnv1a_hash(contents.data(), contents.size(), hash);
+    }
+    return true;
+}
+
+// First cut whose thresholds differ between a and b, or n_cuts + 1 if they are all the same
+inline int first_changed_cut(const CutThresholds& a, const CutThresholds& b) {
+    if (a.y_max_pos != b.y_max_pos || a.y_max_neg != b.y_max_neg || a.x_max_pos != b.x_max_pos || a.x_max_neg != b.x_max_neg
+        || a.x_calo_buffer != b.x_calo_buffer || a.x_foil_buffer != b.x_foil_buffer || a.y_buffer != b.y_buffer) return 3;
+    if (a.t_threshold != b.t_threshold) return 4;
+    if (a.om_geometry_table != b.om_geometry_table) return 4; // only changes where cut 4 gets the gamma OM centre from
+    if (a.min_E != b.min_E) return 5;
+    if (a.max_E_tot != b.max_E_tot) return 6;
+    return n_cuts + 1;
+}
+
+// Branches of "cache_info", one for each member of SelectionCacheInfo
+inline void set_cache_info_branches(TTree* tree, SelectionCacheInfo& info, bool create) {
+    struct { const char* name; Long64_t* value; } longs[] = {
+        {"file_size", &info.file_size}, {"file_mtime", &info.file_mtime}, {"N_orig", &info.N_orig}};
+    struct { const char* name; double* value; } doubles[] = {
+        {"min_E", &info.thresholds.min_E}, {"max_E_tot", &info.thresholds.max_E_tot},
+        {"y_max_pos", &info.thresholds.y_max_pos}, {"y_max_neg", &info.thresholds.y_max_neg},
+        {"x_max_pos", &info.thresholds.x_max_pos}, {"x_max_neg", &info.thresholds.x_max_neg},
+        {"x_calo_buffer", &info.thresholds.x_calo_buffer}, {"x_foil_buffer", &info.thresholds.x_foil_buffer},
+        {"y_buffer", &info.thresholds.y_buffer}, {"t_threshold", &info.thresholds.t_threshold}};
+    if (create) tree->Branch("definition_hash", &info.definition_hash, "definition_hash/l");
+    else tree->SetBranchAddress("definition_hash", &info.definition_hash);
+    if (create) tree->Branch("output_hash", &info.output_hash, "output_hash/l");
+    else if (tree->GetBranch("output_hash")) tree->SetBranchAddress("output_hash", &info.output_hash); // older caches have none
+    if (create) tree->Branch("om_geometry_table", &info.thresholds.om_geometry_table, "om_geometry_table/O");
+    else if (tree->GetBranch("om_geometry_table")) tree->SetBranchAddress("om_geometry_table", &info.thresholds.om_geometry_table);
+    for (auto& b : longs) {
+        if (create) tree->Branch(b.name, b.value, (std::string(b.name) + "/L").c_str());
+        else tree->SetBranchAddress(b.name, b.value);
+    }
+    for (auto& b : doubles) {
+        if (create) tree->Branch(b.name, b.value, (std::string(b.name) + "/D").c_str());
+        else tree->SetBranchAddress(b.name, b.value);
+    }
+}
+
+// Read a cache file, returns false if there is none (or it cannot be read)
+inline bool read_selection_cache(const std::string& cachePath, SelectionCacheInfo& info, std::vector<Long64_t>& entries, std::vector<int>& n_passed) {
+    entries.clear();
+    n_passed.clear();
+    if (gSystem->AccessPathName(cachePath.c_str())) return false; // AccessPathName is true when the file is not there
+    TFile *cacheFile = TFile::Open(cachePath.c_str(), "READ");
+    if (!cacheFile || cacheFile->IsZombie()) {
+        delete cacheFile;
+        return false;
+    }
+    TTree *infoTree = (TTree*) cacheFile->Get("cache_info");
+    TTree *cacheTree = (TTree*) cacheFile->Get("selection_cache");
+    bool ok = infoTree && cacheTree && infoTree->GetEntries() == 1;
+    if (ok) {
+        set_cache_info_branches(infoTree, info, false);
+        infoTree->GetEntry(0);
+        Long64_t entry;
+        UChar_t cut_mask;
+        cacheTree->SetBranchAddress("entry", &entry);
+        cacheTree->SetBranchAddress("cut_mask", &cut_mask);
+        Long64_t n = cacheTree->GetEntries();
+        entries.reserve(n);
+        n_passed.reserve(n);
+        for (Long64_t i = 0; i < n; ++i) {
+            cacheTree->GetEntry(i);
+            int passed = 0;
+            while (passed < n_cuts && (cut_mask & (1 << passed))) passed++;
+            entries.push_back(entry);
+            n_passed.push_back(passed);
+        }
+    }
+    cacheFile->Close();
+    delete cacheFile;
+    return ok;
+}
+
+// Write a cache file (to a temporary file first, so a crash never leaves half a cache behind)
+inline bool write_selection_cache(const std::string& cachePath, SelectionCacheInfo info, const std::vector<Long64_t>& entries, const std::vector<int>& n_passed) {
+    std::string tmpPath = cachePath + ".tmp";
+    TFile *cacheFile = new TFile(tmpPath.c_str(), "RECREATE");
+    if (cacheFile->IsZombie()) {
+        std::cerr << "Error: Cannot write selection cache " << tmpPath << std::endl;
+        delete cacheFile;
+        return false;
+    }
+    TTree *infoTree = new TTree("cache_info", "what the selection cache is valid for");
+    set_cache_info_branches(infoTree, info, true);
+    infoTree->Fill();
+    TTree *cacheTree = new TTree("selection_cache", "events passing cut 1 and how far they got");
+    Long64_t entry;
+    UChar_t cut_mask;
+    cacheTree->Branch("entry", &entry, "entry/L");
+    cacheTree->Branch("cut_mask", &cut_mask, "cut_mask/b");
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entry = entries[i];
+        cut_mask = (1 << n_passed[i]) - 1;
+        cacheTree->Fill();
+    }
+    cacheFile->Write();
+    cacheFile->Close();
+    delete cacheFile;
+    return gSystem->Rename(tmpPath.c_str(), cachePath.c_str()) == 0;
+}
+
+// True if outputFileName holds the counts and output mode SelectionWriter::Close would write for result and options
+inline bool output_file_matches(const char* outputFileName, const SelectionResult& result, const OutputOptions& options) {
+    TFile *outputFile = TFile::Open(outputFileName, "READ");
+    if (!outputFile || outputFile->IsZombie()) {
+        delete outputFile;
+        return false;
+    }
+    bool matches = true;
+    auto check_count = [&](const std::string& name, Long64_t expected) {
+        TParameter<Long64_t>* count = dynamic_cast<TParameter<Long64_t>*>(outputFile->Get(name.c_str()));
+        matches = matches && count && count->GetVal() == expected;
+    };
+    check_count("N_orig", result.N_orig);
+    for (int k = 0; k < n_cuts; ++k) check_count("pass_cut" + std::to_string(k + 1), result.pass_cut[k]);
+    check_count("N_cut", result.N_cut());
+    TNamed* mode = dynamic_cast<TNamed*>(outputFile->Get("output_mode"));
+    matches = matches && mode && options.Description() == mode->GetTitle();
+    outputFile->Close();
+    delete outputFile;
+    return matches;
+}
+
+// Same as run_cuts_V2 in run_cuts_V2.h, but using (and updating) the cache in cacheDirectory
+inline SelectionResult run_cuts_V2_cached(const char* inputFileName, const char* outputFileName, const CutThresholds& thresholds,
+                                          const char* cacheDirectory, bool verbose = true, const OutputOptions& outputOptions = OutputOptions()) {
+    SelectionResult result;
+
+    // What the cache has to match
+    SelectionCacheInfo current;
+    FileStat_t stat;
+    if (gSystem->GetPathInfo(inputFileName, stat) != 0) {
+        std::cerr << "Error: Cannot open input file " << inputFileName << std::endl;
+        return result;
+    }
+    current.file_size = stat.fSize;
+    current.file_mtime = stat.fMtime;
+    if (!cut_definition_hash(current.definition_hash)) {
+        // Without the hash a cache could be out of date without anyone knowing, so cut the whole tree and leave the cache alone
+        std::cerr << "Warning: Not using the selection cache for " << inputFileName << std::endl;
+        return run_cuts_V2(inputFileName, outputFileName, thresholds, true, verbose, outputOptions);
+    }
+    current.output_hash = string_hash(outputOptions.Description().c_str());
+    current.thresholds = thresholds;
+    std::string base_name = gSystem->BaseName(inputFileName); // ie. run_1547.root
+    std::string cachePath = std::string(cacheDirectory) + "/" + base_name.substr(0, base_name.rfind(".root")) + "_selection_cache.root";
+
+    // Work out how much has to be redone
+    SelectionCacheInfo cached;
+    std::vector<Long64_t> entries;
+    std::vector<int> n_passed;
+    bool valid = read_selection_cache(cachePath, cached, entries, n_passed)
+        && cached.file_size == current.file_size && cached.file_mtime == current.file_mtime
+        && cached.definition_hash == current.definition_hash;
+    int first_cut = valid ? first_changed_cut(cached.thresholds, thresholds) : 1;
+    bool have_output = !gSystem->AccessPathName(outputFileName) && cached.output_hash == current.output_hash;
+    if (valid && first_cut > n_cuts && have_output) {
+        // Nothing changed: the counts come straight from the cache
+        SelectionResult cached_result;
+        cached_result.ok = true;
+        cached_result.cache = "hit";
+        cached_result.N_orig = cached.N_orig;
+        for (int passed : n_passed) {
+            for (int k = 0; k < passed; ++k) cached_result.pass_cut[k]++;
+        }
+        // as long as the output file is still the one the cache wrote (cuts_V2.C may have rewritten it since)
+        if (output_file_matches(outputFileName, cached_result, outputOptions)) {
+            if (verbose) std::cout << "\nSelection cache hit for " << inputFileName << ", nothing to do" << std::endl;
+            return cached_result;
+        }
+        if (verbose) std::cout << "\n" << outputFileName << " was rewritten outside the selection cache, filling it again" << std::endl;
+    }
+    if (valid && first_cut > n_cuts) first_cut = n_cuts; // only the output file is missing or different: just refill the survivors
+    result.cache = valid ? "partial" : "miss";
+
+    // Load the dataset
+    TFile *inputFile = TFile::Open(inputFileName, "READ");
+    if (!inputFile || inputFile->IsZombie()) {
+        std::cerr << "Error: Cannot open input file " << inputFileName << std::endl;
+        delete inputFile;
+        return result;
+    }
+    TTree *tree = (TTree*) inputFile->Get("Result_tree");
+    if (!tree) {
+        std::cerr << "Error: Cannot find TTree 'Result_tree' in file " << inputFileName << std::endl;
+        delete inputFile;
+        return result;
+    }
+    ResultTreeEvent event;
+    event.SetBranchAddresses(tree, thresholds.om_geometry_table);
+    StagedResultTree reader;
+    if (!reader.Setup(tree, true)) {
+        delete inputFile;
+        return result;
+    }
+
+    // Prepare output file to store cut data in
+    SelectionWriter writer;
+    if (!writer.Open(outputFileName, tree, outputOptions)) {
+        delete inputFile;
+        return result;
+    }
+
+    Long64_t nEntries = tree->GetEntries();
+    Long64_t n_evaluated = 0;
+    if (!valid) {
+        // Cut the whole tree, keeping every event that passes cut 1 (anything read from an out of date cache is thrown away)
+        entries.clear();
+        n_passed.clear();
+        for (Long64_t i = 0; i < nEntries; ++i) {
+            reader.SetEntry(i);
+            int passed = apply_cuts_from(1, event, thresholds, reader);
+            if (passed == 0) continue;
+            entries.push_back(i);
+            n_passed.push_back(passed);
+            if (passed == n_cuts) writer.Fill(i, event);
+        }
+        n_evaluated = nEntries;
+    } else {
+        // Only the cached events that reached first_cut need looking at again
+        for (size_t e = 0; e < entries.size(); ++e) {
+            if (n_passed[e] < first_cut - 1) continue;
+            reader.SetEntry(entries[e]);
+            n_passed[e] = apply_cuts_from(first_cut, event, thresholds, reader);
+            if (n_passed[e] == n_cuts) writer.Fill(entries[e], event);
+            n_evaluated++;
+        }
+    }
+
+    // Counts, then save the cache for next time
+    result.ok = true;
+    result.N_orig = nEntries;
+    for (int passed : n_passed) {
+        for (int k = 0; k < passed; ++k) result.pass_cut[k]++;
+    }
+    writer.Close(result);
+    inputFile->Close();
+    delete inputFile;
+    current.N_orig = nEntries;
+    write_selection_cache(cachePath, current, entries, n_passed);
+    if (verbose) {
+        std::cout << "\nSelection cache " << result.cache << " for " << inputFileName << ": " << n_evaluated
+                  << " events evaluated (from cut " << first_cut << ")" << std::endl;
+        std::cout << "Saved reduced dataset to " << outputFileName << std::endl;
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,229 @@
+// Last edited 17/10/2026
+// Author: Anya Elvin
+// How the events surviving the 1e1gam cuts are written out, shared by cuts_V2.C, selection_cache.C and parallel_cuts_V2.C
+// Output modes, so the survivors do not always have to be copied out in full:
+    // "full" (default): Result_tree with every branch of the surviving events
+    // "entrylist": no events copied, just a TEntryList "selected_entries" of the surviving entry numbers in the input file.
+    //     To use it: Result_tree->SetEntryList(selected_entries) on the original file
+    // "friend": selected_entries plus "Result_tree_derived", one row per entry of the input Result_tree, with
+    //     passed | dt_meas | dt_exp | L_e | L_g | normalised_diff | E_tot
+    //     so the derived quantities never need working out again. passed is false and the rest NaN for rejected events.
+    //     The rows line up with the original file, so it can be a friend straight away:
+    //     Result_tree->AddFriend("Result_tree_derived", "run_1547_selected.root");
+    //     Result_tree->SetEntryList(selected_entries); Result_tree->Draw("Result_tree_derived.normalised_diff")
+    // "slim": Result_tree with only the branches in slim_branches (comma separated), ie. "energy,calo_tdc,om_number"
+    //     Any top-level branch can be kept, the ones the cuts do not use are read for the survivors only
+// compression: ROOT compression setting of the output file, 100 * algorithm + level (ie. 505 = ZSTD level 5,
+// 207 = LZMA level 7, 404 = LZ4 level 4), -1 = ROOT's default
+// Whatever the mode, the output file also holds the counts as TParameter<Long64_t>: N_orig, pass_cut1 ... pass_cut6, N_cut,
+// and the mode as TNamed "output_mode", so nothing has to open the trees again to count them
+
+#ifndef SELECTION_OUTPUT_H
+#define SELECTION_OUTPUT_H
+
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TNamed.h>
+#include <TObjArray.h>
+#include <TEntryList.h>
+#include <TParameter.h>
+#include "cuts_V2.h"
+
+// How the surviving events are written out (see top of file)
+enum OutputMode { output_full, output_entrylist, output_friend, output_slim };
+const char* const output_mode_names[] = {"full", "entrylist", "friend", "slim"};
+
+struct OutputOptions {
+    OutputMode mode = output_full;
+    std::string slim_branches; // slim mode only, comma separated
+    int compression = -1; // 100 * algorithm + level, -1 = ROOT's default
+
+    // Everything that changes what ends up in the output file, ie. "slim:energy,calo_tdc:505"
+    std::string Description() const {
+        return std::string(output_mode_names[mode]) + ":" + (mode == output_slim ? slim_branches : "") + ":" + std::to_string(compression);
+    }
+};
+
+// Fill options from the macro arguments, returns false (with a message) if they make no sense
+inline bool parse_output_options(const char* outputMode, const char* slimBranches, int compression, OutputOptions& options) {
+    bool found = false;
+    for (int m = 0; m <= output_slim; ++m) {
+        if (std::string(outputMode) == output_mode_names[m]) {
+            options.mode = (OutputMode) m;
+            found = true;
+        }
+    }
+    if (!found) {
+        std::cerr << "Error: Unknown output mode " << outputMode << " (use full, entrylist, friend or slim)" << std::endl;
+        return false;
+    }
+    options.slim_branches = slimBranches;
+    if (options.mode == output_slim && options.slim_branches.empty()) {
+        std::cerr << "Error: slim output mode needs a list of branches to keep" << std::endl;
+        return false;
+    }
+    options.compression = compression;
+    return true;
+}
+
+// Writes the surviving events to the output file in one of the output modes
+// Open before the loop, Fill for every survivor (with its cut branches loaded, Fill reads any other branch being copied),
+// then Close with the counts
+struct SelectionWriter {
+    OutputOptions options;
+    TFile* file = nullptr;
+    TTree* cut_tree = nullptr; // full and slim
+    TEntryList* entry_list = nullptr; // entrylist and friend
+    TTree* derived_tree = nullptr; // friend
+    std::vector<TBranch*> other_branches; // full and slim: branches copied to cut_tree that the cuts never load
+    Long64_t next_entry = 0; // friend: first entry with no row in derived_tree yet
+    bool passed = false;
+    double dt_meas = 0, dt_exp = 0, L_e = 0, L_g = 0, normalised_diff = 0, E_tot = 0;
+
+    bool Open(const char* outputFileName, TTree* tree, const OutputOptions& outputOptions) {
+        options = outputOptions;
+        if (options.compression >= 0) file = new TFile(outputFileName, "RECREATE", "", options.compression);
+        else file = new TFile(outputFileName, "RECREATE");
+        if (file->IsZombie()) {
+            std::cerr << "Error: Cannot open output file " << outputFileName << std::endl;
+            delete file;
+            file = nullptr;
+            return false;
+        }
+        if (options.mode == output_full) {
+            cut_tree = tree->CloneTree(0);
+        } else if (options.mode == output_slim) {
+            // CloneTree only copies the active branches
+            std::vector<std::string> keep;
+            std::stringstream list(options.slim_branches);
+            std::string name;
+            while (std::getline(list, name, ',')) {
+                if (name.empty()) continue;
+                // Only whole top-level branches, those are the ones Fill knows how to read (GetBranch also finds sub-branches)
+                if (!tree->GetListOfBranches()->FindObject(name.c_str())) {
+                    std::cerr << "Error: Cannot find top-level branch " << name << " to keep in Result_tree" << std::endl;
+                    Abort();
+                    return false;
+                }
+                keep.push_back(name);
+            }
+            // Switch off everything else for the clone, then back to how it was, since the cuts still need it
+            // (a branch that was already off, ie. gamma_om_y/z with the OM geometry table, stays off)
+            TObjArray *allBranches = tree->GetListOfBranches();
+            std::vector<std::string> was_on;
+            for (Int_t b = 0; b < allBranches->GetEntriesFast(); ++b) {
+                const char* branch_name = allBranches->At(b)->GetName();
+                if (tree->GetBranchStatus(branch_name)) was_on.push_back(branch_name);
+            }
+            tree->SetBranchStatus("*", 0);
+            for (const std::string& b : keep) {
+                if (std::find(was_on.begin(), was_on.end(), b) == was_on.end()) {
+                    std::cerr << "Warning: branch " << b << " is not being read, leaving it out of the slim copy" << std::endl;
+                    continue;
+                }
+                tree->SetBranchStatus(b.c_str(), 1);
+            }
+            cut_tree = tree->CloneTree(0);
+            for (const std::string& b : was_on) tree->SetBranchStatus(b.c_str(), 1);
+        } else {
+            entry_list = new TEntryList("selected_entries", "entries of Result_tree passing the 1e1gam cuts", tree);
+            entry_list->SetDirectory(nullptr); // written by hand in Close
+        }
+        if (cut_tree) {
+            // The staged reader only loads the cut branches, anything else being copied is read in Fill
+            TObjArray *copied = cut_tree->GetListOfBranches();
+            for (Int_t b = 0; b < copied->GetEntriesFast(); ++b) {
+                const char* branch_name = copied->At(b)->GetName();
+                if (!is_cut_branch(branch_name)) other_branches.push_back(tree->GetBranch(branch_name));
+            }
+        }
+        if (options.mode == output_friend) {
+            derived_tree = new TTree("Result_tree_derived", "derived quantities of the events passing the 1e1gam cuts");
+            derived_tree->Branch("passed", &passed, "passed/O");
+            derived_tree->Branch("dt_meas", &dt_meas, "dt_meas/D");
+            derived_tree->Branch("dt_exp", &dt_exp, "dt_exp/D");
+            derived_tree->Branch("L_e", &L_e, "L_e/D");
+            derived_tree->Branch("L_g", &L_g, "L_g/D");
+            derived_tree->Branch("normalised_diff", &normalised_diff, "normalised_diff/D");
+            derived_tree->Branch("E_tot", &E_tot, "E_tot/D");
+        }
+        return true;
+    }
+
+    // Friend mode: a rejected row for every entry before entryNumber that has none yet
+    void FillRejected(Long64_t entryNumber) {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        passed = false;
+        dt_meas = dt_exp = L_e = L_g = normalised_diff = E_tot = nan;
+        for (; next_entry < entryNumber; ++next_entry) derived_tree->Fill();
+    }
+
+    // entryNumber: entry in the input Result_tree (a TTree, not a TChain), whose cut branches have all been loaded
+    // Survivors must be filled in increasing entry order (the derived tree is padded up to each one)
+    void Fill(Long64_t entryNumber, const ResultTreeEvent& ev) {
+        if (cut_tree) {
+            for (TBranch* branch : other_branches) branch->GetEntry(entryNumber);
+            cut_tree->Fill();
+        }
+        if (entry_list) entry_list->Enter(entryNumber);
+        if (derived_tree) {
+            FillRejected(entryNumber);
+            TimingInputs in;
+            TimingQuantities q;
+            if (get_timing_inputs(ev, in)) timing_quantities_scalar(in, q); // always true for events that passed cut 4
+            passed = true;
+            dt_meas = q.dt_meas;
+            dt_exp = q.dt_exp;
+            L_e = q.L_e;
+            L_g = q.L_g;
+            normalised_diff = q.normalised_diff;
+            E_tot = ev.energy->at(e_idx) + ev.energy->at(g_idx);
+            derived_tree->Fill();
+            next_entry = entryNumber + 1;
+        }
+    }
+
+    // Writes everything, counts included, and closes the file
+    void Close(const SelectionResult& result) {
+        file->cd();
+        if (derived_tree) FillRejected(result.N_orig); // rows for the rejected events after the last survivor
+        if (cut_tree) cut_tree->Write();
+        if (entry_list) entry_list->Write();
+        if (derived_tree) derived_tree->Write();
+        TParameter<Long64_t>("N_orig", result.N_orig).Write();
+        for (int k = 0; k < n_cuts; ++k) {
+            TParameter<Long64_t>(("pass_cut" + std::to_string(k + 1)).c_str(), result.pass_cut[k]).Write();
+        }
+        TParameter<Long64_t>("N_cut", result.N_cut()).Write();
+        TNamed("output_mode", options.Description().c_str()).Write();
+        file->Close();
+        delete entry_list;
+        delete file;
+        file = nullptr;
+        entry_list = nullptr;
+    }
+
+    // Give up on the output file
+    void Abort() {
+        delete entry_list;
+        delete file;
+        file = nullptr;
+        entry_list = nullptr;
+    }
+};
+
+// Prints the counts in a fixed format ("N_orig: 123"), which the pipelines read instead of reopening the files
+inline void print_counts(const SelectionResult& result) {
+    std::cout << "N_orig: " << result.N_orig << std::endl;
+    for (int k = 0; k < n_cuts; ++k) std::cout << "pass_cut" << k + 1 << ": " << result.pass_cut[k] << std::endl;
+    std::cout << "N_cut: " << result.N_cut() << std::endl;
+}
+
+#endif
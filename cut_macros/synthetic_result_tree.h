@@ -0,0 +1,271 @@
+// Last edited 17/10/2026
+// Author: Anya Elvin
+// Synthetic events with the same Result_tree branches as the real data and simulation (see ResultTreeEvent in cuts_V2.h),
+// so the selection can be run and timed without the files on /sps/nemo
+// Each event is made like this:
+    // electron_number, gamma_number: Poisson with means electron_mean, gamma_mean (at most max_particles each)
+    // energy, calo_tdc, om_number: one entry per calorimeter hit, electrons first then gammas
+    // first_vertex_x/y/z, second_vertex_x/y/z: one entry per electron. The first vertex is uniform in the tracker,
+    //     the second is on the calorimeter wall on the same side, track_spread (mm) away in y and z
+    // gamma_om_x/y/z: one entry per gamma, the centre of its OM (from om_geometry.h). With probability
+    //     p_om_outside_main the OM is not on the main walls (om_number > 519)
+    // electron and gamma energies: exponential with means electron_energy_mean, gamma_energy_mean (MeV)
+    // calo_tdc: the gamma at a random time, the electron at the time expected for 1e1gam (timing_kernel.h) plus a
+    //     gaussian of width tdc_sigma (ns), except for a fraction p_external where it is anywhere in ±external_window (ns)
+// The defaults give about 3% of events passing all six cuts, roughly what the data does.
+// Any setting can be changed with a spec string, ie. "electron_mean=0.6;p_external=0.3" (see parse_synthetic_config)
+// write_synthetic_result_tree writes a whole file of them, used by cut_macros/make_synthetic_result_tree.C and benchmarks/selection_benchmark.C
+
+#ifndef SYNTHETIC_RESULT_TREE_H
+#define SYNTHETIC_RESULT_TREE_H
+
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <TFile.h>
+#include <TTree.h>
+#include "cuts_V2.h"
+#include "om_geometry.h"
+
+struct SyntheticConfig {
+    double electron_mean = 0.5;
+    double gamma_mean = 0.5;
+    double max_particles = 4;
+    double p_om_outside_main = 0.15;
+    double vertex_x_max = 436; // mm, same as the tracker edges in CutThresholds
+    double vertex_y_max = 2494;
+    double vertex_z_max = 1500;
+    double track_spread = 300; // mm
+    double electron_energy_mean = 0.8; // MeV
+    double gamma_energy_mean = 1.0; // MeV
+    double tdc_sigma = 0.4; // ns
+    double p_external = 0.2;
+    double external_window = 50; // ns
+};
+
+// Settings that can be changed by name
+struct SyntheticSetting { const char* name; double* value; };
+inline std::vector<SyntheticSetting> synthetic_settings(SyntheticConfig& config) {
+    return {{"electron_mean", &config.electron_mean}, {"gamma_mean", &config.gamma_mean},
+            {"max_particles", &config.max_particles}, {"p_om_outside_main", &config.p_om_outside_main},
+            {"vertex_x_max", &config.vertex_x_max}, {"vertex_y_max", &config.vertex_y_max},
+            {"vertex_z_max", &config.vertex_z_max}, {"track_spread", &config.track_spread},
+            {"electron_energy_mean", &config.electron_energy_mean}, {"gamma_energy_mean", &config.gamma_energy_mean},
+            {"tdc_sigma", &config.tdc_sigma}, {"p_external", &config.p_external},
+            {"external_window", &config.external_window}};
+}
+
+// Read "name=value;name=value" into config, returns false (with a message) if a setting is not recognised
+inline bool parse_synthetic_config(const std::string& spec, SyntheticConfig& config) {
+    std::stringstream items(spec);
+    std::string item;
+    while (std::getline(items, item, ';')) {
+        if (item.empty()) continue;
+        size_t eq = item.find('=');
+        std::string name = item.substr(0, eq);
+        bool found = false;
+        for (SyntheticSetting& s : synthetic_settings(config)) {
+            if (eq == std::string::npos || name != s.name) continue;
+            *s.value = std::stod(item.substr(eq + 1));
+            found = true;
+        }
+        if (!found) {
+            std::cerr << "Error: Unknown synthetic setting " << item << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// One synthetic event, owning the vectors the branches point to
+struct SyntheticEvent {
+    Int_t electron_number = 0, gamma_number = 0;
+    std::vector<double> energy, first_vertex_x, first_vertex_y, first_vertex_z;
+    std::vector<double> second_vertex_x, second_vertex_y, second_vertex_z;
+    std::vector<int> om_number;
+    std::vector<double> calo_tdc, gamma_om_x, gamma_om_y, gamma_om_z;
+    // pointers for the branches (ROOT wants the address of a pointer to each vector)
+    std::vector<double>* energy_ptr = &energy;
+    std::vector<double>* first_vertex_x_ptr = &first_vertex_x;
+    std::vector<double>* first_vertex_y_ptr = &first_vertex_y;
+    std::vector<double>* first_vertex_z_ptr = &first_vertex_z;
+    std::vector<double>* second_vertex_x_ptr = &second_vertex_x;
+    std::vector<double>* second_vertex_y_ptr = &second_vertex_y;
+    std::vector<double>* second_vertex_z_ptr = &second_vertex_z;
+    std::vector<int>* om_number_ptr = &om_number;
+    std::vector<double>* calo_tdc_ptr = &calo_tdc;
+    std::vector<double>* gamma_om_x_ptr = &gamma_om_x;
+    std::vector<double>* gamma_om_y_ptr = &gamma_om_y;
+    std::vector<double>* gamma_om_z_ptr = &gamma_om_z;
+
+    SyntheticEvent() = default;
+    SyntheticEvent(const SyntheticEvent&) = delete; // the pointers would point into the other event
+    SyntheticEvent& operator=(const SyntheticEvent&) = delete;
+
+    // Create the Result_tree branches in tree, with the same types as the real files
+    void MakeBranches(TTree* tree) {
+        tree->Branch("electron_number", &electron_number, "electron_number/I");
+        tree->Branch("gamma_number", &gamma_number, "gamma_number/I");
+        tree->Branch("energy", &energy_ptr);
+        tree->Branch("first_vertex_x", &first_vertex_x_ptr);
+        tree->Branch("first_vertex_y", &first_vertex_y_ptr);
+        tree->Branch("first_vertex_z", &first_vertex_z_ptr);
+        tree->Branch("second_vertex_x", &second_vertex_x_ptr);
+        tree->Branch("second_vertex_y", &second_vertex_y_ptr);
+        tree->Branch("second_vertex_z", &second_vertex_z_ptr);
+        tree->Branch("om_number", &om_number_ptr);
+        tree->Branch("calo_tdc", &calo_tdc_ptr);
+        tree->Branch("gamma_om_x", &gamma_om_x_ptr);
+        tree->Branch("gamma_om_y", &gamma_om_y_ptr);
+        tree->Branch("gamma_om_z", &gamma_om_z_ptr);
+    }
+
+    // Point ev at this event, so the cuts can be applied to it directly
+    void View(ResultTreeEvent& ev) {
+        ev.electron_number = electron_number;
+        ev.gamma_number = gamma_number;
+        ev.energy = &energy;
+        ev.first_vertex_x = &first_vertex_x;
+        ev.first_vertex_y = &first_vertex_y;
+        ev.first_vertex_z = &first_vertex_z;
+        ev.second_vertex_x = &second_vertex_x;
+        ev.second_vertex_y = &second_vertex_y;
+        ev.second_vertex_z = &second_vertex_z;
+        ev.om_number = &om_number;
+        ev.calo_tdc = &calo_tdc;
+        ev.gamma_om_x = &gamma_om_x;
+        ev.gamma_om_y = &gamma_om_y;
+        ev.gamma_om_z = &gamma_om_z;
+    }
+};
+
+// Makes synthetic events one after the other, always the same ones for the same seed and config
+struct SyntheticGenerator {
+    SyntheticConfig config;
+    std::mt19937_64 rng;
+
+    SyntheticGenerator(const SyntheticConfig& syntheticConfig, unsigned long long seed) : config(syntheticConfig), rng(seed) {}
+
+    double Uniform(double lo, double hi) { return std::uniform_real_distribution<double>(lo, hi)(rng); }
+    double Gauss(double sigma) { return std::normal_distribution<double>(0.0, sigma)(rng); }
+    double Exponential(double mean) { return std::exponential_distribution<double>(1.0 / mean)(rng); }
+    int Multiplicity(double mean) { return std::min<int>(std::poisson_distribution<int>(mean)(rng), (int) config.max_particles); }
+
+    void Next(SyntheticEvent& event) {
+        event.electron_number = Multiplicity(config.electron_mean);
+        event.gamma_number = Multiplicity(config.gamma_mean);
+        event.energy.clear();
+        event.first_vertex_x.clear();
+        event.first_vertex_y.clear();
+        event.first_vertex_z.clear();
+        event.second_vertex_x.clear();
+        event.second_vertex_y.clear();
+        event.second_vertex_z.clear();
+        event.om_number.clear();
+        event.calo_tdc.clear();
+        event.gamma_om_x.clear();
+        event.gamma_om_y.clear();
+        event.gamma_om_z.clear();
+
+        // Gammas first (the electron times depend on where the first gamma went), stored after the electrons
+        std::vector<int> gamma_oms;
+        std::vector<double> gamma_energies;
+        for (int g = 0; g < event.gamma_number; ++g) {
+            double x, y, z;
+            int om;
+            if (Uniform(0, 1) < config.p_om_outside_main) {
+                // X-wall or veto OM somewhere off the main walls
+                om = 520 + (int) Uniform(0, 192);
+                x = Uniform(-config.vertex_x_max, config.vertex_x_max);
+                y = Uniform(0, 1) < 0.5 ? -2700.0 : 2700.0;
+                z = Uniform(-config.vertex_z_max, config.vertex_z_max);
+            } else {
+                om = (int) Uniform(0, n_main_wall_oms);
+                om_centre(om, x, y, z);
+            }
+            gamma_oms.push_back(om);
+            gamma_energies.push_back(Exponential(config.gamma_energy_mean));
+            event.gamma_om_x.push_back(x);
+            event.gamma_om_y.push_back(y);
+            event.gamma_om_z.push_back(z);
+        }
+        double t_g = Uniform(0, 100);
+
+        for (int e = 0; e < event.electron_number; ++e) {
+            TimingInputs in;
+            in.x1 = Uniform(-config.vertex_x_max, config.vertex_x_max);
+            in.y1 = Uniform(-config.vertex_y_max, config.vertex_y_max);
+            in.z1 = Uniform(-config.vertex_z_max, config.vertex_z_max);
+            int side = in.x1 < 0 ? 0 : 1;
+            in.x2 = side == 0 ? -config.vertex_x_max : config.vertex_x_max;
+            in.y2 = std::min(std::max(in.y1 + Gauss(config.track_spread), -config.vertex_y_max), config.vertex_y_max);
+            in.z2 = std::min(std::max(in.z1 + Gauss(config.track_spread), -config.vertex_z_max), config.vertex_z_max);
+            in.T_e = Exponential(config.electron_energy_mean);
+            in.t_g_meas = t_g;
+            double t_e = t_g + Uniform(-config.external_window, config.external_window);
+            if (event.gamma_number > 0 && Uniform(0, 1) >= config.p_external) {
+                in.xg = event.gamma_om_x[0];
+                in.yg = event.gamma_om_y[0];
+                in.zg = event.gamma_om_z[0];
+                TimingQuantities q;
+                if (timing_quantities_scalar(in, q)) t_e = t_g + q.dt_exp + Gauss(config.tdc_sigma);
+            }
+            event.energy.push_back(in.T_e);
+            event.calo_tdc.push_back(t_e);
+            event.om_number.push_back(nearest_main_wall_om(side, in.y2, in.z2));
+            event.first_vertex_x.push_back(in.x1);
+            event.first_vertex_y.push_back(in.y1);
+            event.first_vertex_z.push_back(in.z1);
+            event.second_vertex_x.push_back(in.x2);
+            event.second_vertex_y.push_back(in.y2);
+            event.second_vertex_z.push_back(in.z2);
+        }
+        for (int g = 0; g < event.gamma_number; ++g) {
+            event.energy.push_back(gamma_energies[g]);
+            event.calo_tdc.push_back(g == 0 ? t_g : Uniform(0, 100)); // any other gammas are unrelated
+            event.om_number.push_back(gamma_oms[g]);
+        }
+    }
+};
+
+// Writes nEvents synthetic events to outputFileName, and how many pass each cut to pass_cut (if given)
+inline bool write_synthetic_result_tree(const char* outputFileName, Long64_t nEvents, unsigned long long seed, const SyntheticConfig& config,
+                                        Long64_t* pass_cut = nullptr) {
+    TFile *outputFile = new TFile(outputFileName, "RECREATE");
+    if (outputFile->IsZombie()) {
+        std::cerr << "Error: Cannot open output file " << outputFileName << std::endl;
+        delete outputFile;
+        return false;
+    }
+    TTree *tree = new TTree("Result_tree", "synthetic 1e1gam events");
+    SyntheticEvent event;
+    event.MakeBranches(tree);
+
+    SyntheticGenerator generator(config, seed);
+    ResultTreeEvent view;
+    CutThresholds thresholds;
+    Long64_t counts[n_cuts] = {0};
+    for (Long64_t i = 0; i < nEvents; ++i) {
+        generator.Next(event);
+        tree->Fill();
+        event.View(view);
+        for (int cut = 1; cut <= n_cuts; ++cut) {
+            if (!passes_cut(cut, view, thresholds)) break;
+            counts[cut - 1]++;
+        }
+    }
+
+    outputFile->cd();
+    tree->Write();
+    outputFile->Close();
+    delete outputFile;
+    if (pass_cut) {
+        for (int k = 0; k < n_cuts; ++k) pass_cut[k] = counts[k];
+    }
+    return true;
+}
+
+#endif
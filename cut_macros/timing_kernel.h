@@ -0,0 +1,261 @@
+// Last edited 17/10/2026
+// Author: Anya Elvin
+// Timing test of the 1e1gam channel (cut 4), for one event or for a whole block of events at once
+// For each event:
+    // dt_meas = t_e - t_g (measured calorimeter times)
+    // dt_exp = L_e / (beta_e * c) - L_g / c, with beta_e from the electron kinetic energy, L_e the electron track
+    // length (first to second vertex) and L_g the gamma path (electron first vertex to the gamma's OM)
+    // normalised_diff = |dt_meas - dt_exp| / L_e, the event passes if normalised_diff ≤ t_threshold
+// timing_quantities_scalar is the reference, one event at a time, and is what cut 4 in cuts_V2.h uses
+// timing_pass_mask does the same for a block of events stored as one array per quantity (TimingBlock), 4 (AVX) or
+// 2 (SSE2) events per instruction. Every operation is a plain IEEE add/sub/mul/div/sqrt, done in the same order as the
+// scalar reference, so both give bit-for-bit the same normalised_diff and the same pass/fail on every event
+    // (the one thing that could break this is the compiler fusing a multiply and an add into an FMA in one path and
+    // not the other, so contraction is switched off for the timing functions, see the pragmas below)
+// timing_pass_mask only pays off when the events are already stored as a TimingBlock: copying them in from one event at a
+// time is slower than the scalar reference (BM_TimingGatherBlock), so run_cuts_V2, parallel_cuts_V2 and threshold_scan.C
+// all use timing_quantities_scalar
+// Nothing in here depends on ROOT or on the 1e1gam branches, so it can be reused by any other timing-based channel
+// Used by cut_macros/cuts_V2.h, cut_macros/threshold_scan.C and benchmarks/timing_kernel_benchmark.cpp
+
+#ifndef TIMING_KERNEL_H
+#define TIMING_KERNEL_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+const double c_mm_per_ns = 299.792458; // mm/ns
+const double m_e_MeV = 0.511; // MeV
+
+// Everything the timing test needs for one event
+struct TimingInputs {
+    double t_e_meas = 0, t_g_meas = 0; // ns
+    double T_e = 0; // electron kinetic energy, MeV
+    double x1 = 0, y1 = 0, z1 = 0; // electron first vertex, mm
+    double x2 = 0, y2 = 0, z2 = 0; // electron second vertex, mm
+    double xg = 0, yg = 0, zg = 0; // centre of the gamma's OM, mm
+};
+
+// Quantities worked out by the timing test, kept so they can be stored alongside the selection
+struct TimingQuantities {
+    double dt_meas = 0;
+    double dt_exp = 0;
+    double L_e = 0;
+    double L_g = 0;
+    double normalised_diff = 0;
+};
+
+// The scalar and SIMD paths must round the same way: no fused multiply-adds in the timing maths. Only the two timing
+// functions are inside these pragmas, since GCC will not inline a function compiled with different optimisation
+// options into its caller, so the pack_* helpers and the ROOT-side code calling them must stay outside
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// Scalar reference: returns false if the event cannot be used at all (E_e ≤ m_e or beta_e not in (0, 1)),
+// otherwise fills q and returns true. Whether it passes is then !(q.normalised_diff > t_threshold)
+inline bool timing_quantities_scalar(const TimingInputs& in, TimingQuantities& q) {
+    // Data:
+    double dt_meas = in.t_e_meas - in.t_g_meas;
+    // 1e1gam theory:
+    // electron energy
+    double E_e = in.T_e + m_e_MeV;
+    if (E_e <= m_e_MeV) return false;
+    double ratio = m_e_MeV / E_e;
+    double beta_e = std::sqrt(1.0 - ratio * ratio);
+    if (beta_e <= 0 || beta_e >= 1) return false;
+    // electron track length
+    double dx_e = in.x1 - in.x2;
+    double dy_e = in.y1 - in.y2;
+    double dz_e = in.z1 - in.z2;
+    double L_e = std::sqrt(dx_e * dx_e + dy_e * dy_e + dz_e * dz_e);
+    // gamma track length
+    double dx_g = in.x1 - in.xg;
+    double dy_g = in.y1 - in.yg;
+    double dz_g = in.z1 - in.zg;
+    double L_g = std::sqrt(dx_g * dx_g + dy_g * dy_g + dz_g * dz_g);
+    // expected dt
+    double t_e_exp = L_e / (beta_e * c_mm_per_ns);
+    double t_g_exp = L_g / c_mm_per_ns;
+    double dt_exp = t_e_exp - t_g_exp;
+    // Compare 1e1gam theory vs data
+    q.dt_meas = dt_meas;
+    q.dt_exp = dt_exp;
+    q.L_e = L_e;
+    q.L_g = L_g;
+    q.normalised_diff = std::fabs(dt_meas - dt_exp) / L_e;
+    return true;
+}
+
+inline bool timing_passes_scalar(const TimingInputs& in, double t_threshold) {
+    TimingQuantities q;
+    if (!timing_quantities_scalar(in, q)) return false;
+    return !(q.normalised_diff > t_threshold);
+}
+
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT DEFAULT
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+// A block of events, one array per quantity (struct of arrays) so a whole SIMD register of events can be loaded at once
+struct TimingBlock {
+    std::vector<double> t_e_meas, t_g_meas, T_e, x1, y1, z1, x2, y2, z2, xg, yg, zg;
+
+    size_t size() const { return T_e.size(); }
+    void clear() {
+        for (std::vector<double>* column : columns()) column->clear();
+    }
+    void reserve(size_t n) {
+        for (std::vector<double>* column : columns()) column->reserve(n);
+    }
+    void resize(size_t n) {
+        for (std::vector<double>* column : columns()) column->resize(n);
+    }
+    // Overwrite event i (after resize, this is cheaper than push_back when the block size is known)
+    void set(size_t i, const TimingInputs& in) {
+        t_e_meas[i] = in.t_e_meas; t_g_meas[i] = in.t_g_meas; T_e[i] = in.T_e;
+        x1[i] = in.x1; y1[i] = in.y1; z1[i] = in.z1;
+        x2[i] = in.x2; y2[i] = in.y2; z2[i] = in.z2;
+        xg[i] = in.xg; yg[i] = in.yg; zg[i] = in.zg;
+    }
+    void push_back(const TimingInputs& in) {
+        t_e_meas.push_back(in.t_e_meas); t_g_meas.push_back(in.t_g_meas); T_e.push_back(in.T_e);
+        x1.push_back(in.x1); y1.push_back(in.y1); z1.push_back(in.z1);
+        x2.push_back(in.x2); y2.push_back(in.y2); z2.push_back(in.z2);
+        xg.push_back(in.xg); yg.push_back(in.yg); zg.push_back(in.zg);
+    }
+    TimingInputs get(size_t i) const {
+        TimingInputs in;
+        in.t_e_meas = t_e_meas[i]; in.t_g_meas = t_g_meas[i]; in.T_e = T_e[i];
+        in.x1 = x1[i]; in.y1 = y1[i]; in.z1 = z1[i];
+        in.x2 = x2[i]; in.y2 = y2[i]; in.z2 = z2[i];
+        in.xg = xg[i]; in.yg = yg[i]; in.zg = zg[i];
+        return in;
+    }
+
+private:
+    std::vector<std::vector<double>*> columns() {
+        return {&t_e_meas, &t_g_meas, &T_e, &x1, &y1, &z1, &x2, &y2, &z2, &xg, &yg, &zg};
+    }
+};
+
+// SIMD building blocks: pack_d holds pack_size doubles
+#if defined(__AVX__)
+typedef __m256d pack_d;
+const size_t pack_size = 4;
+inline pack_d pack_load(const double* p) { return _mm256_loadu_pd(p); }
+inline void pack_store(double* p, pack_d a) { _mm256_storeu_pd(p, a); }
+inline pack_d pack_set(double a) { return _mm256_set1_pd(a); }
+inline pack_d pack_add(pack_d a, pack_d b) { return _mm256_add_pd(a, b); }
+inline pack_d pack_sub(pack_d a, pack_d b) { return _mm256_sub_pd(a, b); }
+inline pack_d pack_mul(pack_d a, pack_d b) { return _mm256_mul_pd(a, b); }
+inline pack_d pack_div(pack_d a, pack_d b) { return _mm256_div_pd(a, b); }
+inline pack_d pack_sqrt(pack_d a) { return _mm256_sqrt_pd(a); }
+inline pack_d pack_abs(pack_d a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+inline pack_d pack_and(pack_d a, pack_d b) { return _mm256_and_pd(a, b); }
+inline pack_d pack_or(pack_d a, pack_d b) { return _mm256_or_pd(a, b); }
+// every lane all ones (true) or all zeros (false), for and-ing a per-event condition into a compare mask
+inline pack_d pack_mask(bool b) { return _mm256_castsi256_pd(_mm256_set1_epi64x(b ? -1 : 0)); }
+// !(a <= b), !(a >= b), !(a > b), !(a < b): true when either side is NaN, the same as the scalar tests
+inline pack_d pack_not_le(pack_d a, pack_d b) { return _mm256_cmp_pd(a, b, _CMP_NLE_UQ); }
+inline pack_d pack_not_ge(pack_d a, pack_d b) { return _mm256_cmp_pd(a, b, _CMP_NGE_UQ); }
+inline pack_d pack_not_gt(pack_d a, pack_d b) { return _mm256_cmp_pd(a, b, _CMP_NGT_UQ); }
+inline pack_d pack_not_lt(pack_d a, pack_d b) { return _mm256_cmp_pd(a, b, _CMP_NLT_UQ); }
+inline int pack_movemask(pack_d a) { return _mm256_movemask_pd(a); }
+#elif defined(__SSE2__)
+typedef __m128d pack_d;
+const size_t pack_size = 2;
+inline pack_d pack_load(const double* p) { return _mm_loadu_pd(p); }
+inline void pack_store(double* p, pack_d a) { _mm_storeu_pd(p, a); }
+inline pack_d pack_set(double a) { return _mm_set1_pd(a); }
+inline pack_d pack_add(pack_d a, pack_d b) { return _mm_add_pd(a, b); }
+inline pack_d pack_sub(pack_d a, pack_d b) { return _mm_sub_pd(a, b); }
+inline pack_d pack_mul(pack_d a, pack_d b) { return _mm_mul_pd(a, b); }
+inline pack_d pack_div(pack_d a, pack_d b) { return _mm_div_pd(a, b); }
+inline pack_d pack_sqrt(pack_d a) { return _mm_sqrt_pd(a); }
+inline pack_d pack_abs(pack_d a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+inline pack_d pack_and(pack_d a, pack_d b) { return _mm_and_pd(a, b); }
+inline pack_d pack_or(pack_d a, pack_d b) { return _mm_or_pd(a, b); }
+inline pack_d pack_mask(bool b) { return _mm_castsi128_pd(_mm_set1_epi64x(b ? -1 : 0)); }
+inline pack_d pack_not_le(pack_d a, pack_d b) { return _mm_cmpnle_pd(a, b); }
+inline pack_d pack_not_ge(pack_d a, pack_d b) { return _mm_cmpnge_pd(a, b); }
+inline pack_d pack_not_gt(pack_d a, pack_d b) { return _mm_cmpngt_pd(a, b); }
+inline pack_d pack_not_lt(pack_d a, pack_d b) { return _mm_cmpnlt_pd(a, b); }
+inline int pack_movemask(pack_d a) { return _mm_movemask_pd(a); }
+#else
+const size_t pack_size = 0; // no SIMD available, timing_pass_mask falls back to the scalar reference
+#endif
+
+// Contraction off again for the SIMD timing maths (the pack_* helpers are inlined into it, so they follow these settings)
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// Timing test for every event in block: pass[i] = 1 if event i passes, 0 if not
+// If normalised_diff is given it is filled too (only meaningful where the event could be used at all)
+inline void timing_pass_mask(const TimingBlock& block, double t_threshold, unsigned char* pass, double* normalised_diff = nullptr) {
+    const size_t n = block.size();
+    size_t i = 0;
+#if defined(__AVX__) || defined(__SSE2__)
+    const pack_d m_e_pack = pack_set(m_e_MeV);
+    const pack_d c_pack = pack_set(c_mm_per_ns);
+    const pack_d one = pack_set(1.0);
+    const pack_d zero = pack_set(0.0);
+    const pack_d threshold = pack_set(t_threshold);
+    for (; i + pack_size <= n; i += pack_size) {
+        // Data:
+        pack_d dt_meas = pack_sub(pack_load(&block.t_e_meas[i]), pack_load(&block.t_g_meas[i]));
+        // electron energy (lanes with E_e ≤ m_e end up with a NaN beta_e, they are masked off below)
+        pack_d E_e = pack_add(pack_load(&block.T_e[i]), m_e_pack);
+        pack_d ratio = pack_div(m_e_pack, E_e);
+        pack_d beta_e = pack_sqrt(pack_sub(one, pack_mul(ratio, ratio)));
+        // electron track length
+        pack_d x1 = pack_load(&block.x1[i]), y1 = pack_load(&block.y1[i]), z1 = pack_load(&block.z1[i]);
+        pack_d dx_e = pack_sub(x1, pack_load(&block.x2[i]));
+        pack_d dy_e = pack_sub(y1, pack_load(&block.y2[i]));
+        pack_d dz_e = pack_sub(z1, pack_load(&block.z2[i]));
+        pack_d L_e = pack_sqrt(pack_add(pack_add(pack_mul(dx_e, dx_e), pack_mul(dy_e, dy_e)), pack_mul(dz_e, dz_e)));
+        // gamma track length
+        pack_d dx_g = pack_sub(x1, pack_load(&block.xg[i]));
+        pack_d dy_g = pack_sub(y1, pack_load(&block.yg[i]));
+        pack_d dz_g = pack_sub(z1, pack_load(&block.zg[i]));
+        pack_d L_g = pack_sqrt(pack_add(pack_add(pack_mul(dx_g, dx_g), pack_mul(dy_g, dy_g)), pack_mul(dz_g, dz_g)));
+        // expected dt
+        pack_d dt_exp = pack_sub(pack_div(L_e, pack_mul(beta_e, c_pack)), pack_div(L_g, c_pack));
+        pack_d diff = pack_div(pack_abs(pack_sub(dt_meas, dt_exp)), L_e);
+        // Same tests as the scalar reference, in the same NaN-safe form
+        pack_d ok = pack_and(pack_and(pack_not_le(E_e, m_e_pack), pack_not_le(beta_e, zero)),
+                             pack_and(pack_not_ge(beta_e, one), pack_not_gt(diff, threshold)));
+        int bits = pack_movemask(ok);
+        for (size_t lane = 0; lane < pack_size; ++lane) pass[i + lane] = (bits >> lane) & 1;
+        if (normalised_diff) pack_store(&normalised_diff[i], diff);
+    }
+#endif
+    // Whatever is left over (less than one pack)
+    for (; i < n; ++i) {
+        TimingQuantities q;
+        bool usable = timing_quantities_scalar(block.get(i), q);
+        pass[i] = usable && !(q.normalised_diff > t_threshold);
+        if (normalised_diff) normalised_diff[i] = usable ? q.normalised_diff : NAN;
+    }
+}
+
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT DEFAULT
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,17 @@
+# Last edited 17/10/2026
+# Author: Anya Elvin
+# Counts printed by the cut macros (print_counts in cut_macros/selection_output.h), shared by real_data_pipeline.py and simulation_pipeline.py
+
+def parse_counts(macro_output):
+    """
+    Read the counts the cut macro prints at the end ("N_orig: 123", "pass_cut1: 45", ..., "N_cut: 6")
+    so the cut files never need opening again to count their entries
+    """
+    counts = {}
+    for line in macro_output.splitlines():
+        name, sep, value = line.partition(": ")
+        if sep and (name in ("N_orig", "N_cut") or name.startswith("pass_cut")) and value.strip().isdigit():
+            counts[name] = int(value)
+    if "N_orig" not in counts or "N_cut" not in counts:
+        raise RuntimeError("Cut macro did not print its counts")
+    return counts
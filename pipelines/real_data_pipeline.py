@@ -1,4 +1,4 @@
-# Last edited 01/12/2025
+# Last edited 17/10/2026
 # Author: Anya Elvin
 # Code to run data files through in order to apply cuts, calculate activity and append information to a csv
 # csv headings: run | time | duration | phase | N_orig | N_cut | cut_file | activity | activity_uncertainty
@@ -6,27 +6,47 @@
 # STILL TO DO: calculate proper errors
 # Change the thresholds
 # Before running this code, do "module load root" in the terminal window below
+# run_batch_pipeline (the default) cuts every run in one compiled ROOT process (cut_macros/batch_cuts_V2.C) and writes the csv once at the end
+# run_pipeline is the old one-run-at-a-time version
 
 import subprocess
-import uproot
 import csv
 import os
 import pandas as pd
+from cut_counts import parse_counts
 
 # Paths to files and constants
 data_directory = "/sps/nemo/scratch/elvin/data"
 cut_data_directory = "/sps/nemo/scratch/elvin/cut_data"
 metadata_file_1 = "/sps/nemo/scratch/elvin/metadata_lists/UDD_betabeta_v1.list"
-metadata_file_2 = "/sps/nemo/scratch/elvin/metadata_lists/UDD_betabeta_v1.list"
+metadata_file_2 = "/sps/nemo/scratch/elvin/metadata_lists/UDD_betabeta_v2.list"
 cut_macro = "/sps/nemo/scratch/elvin/cut_macros/cuts_V2.C" # Change this when cuts change
+batch_macro = "/sps/nemo/scratch/elvin/cut_macros/batch_cuts_V2.C"
+batch_list = "/sps/nemo/scratch/elvin/cut_data/batch_runs.list"
+batch_counts_csv = "/sps/nemo/scratch/elvin/cut_data/batch_counts.csv"
+selection_cache_directory = "/sps/nemo/scratch/elvin/cut_data/selection_cache" # set to "" to always re-cut every run from scratch
+n_threads = 0 # 0 = one thread per core
+output_mode = "full" # how the survivors are written: "full", "entrylist", "friend" or "slim", see cut_macros/selection_output.h
+slim_branches = "" # branches to keep in "slim" mode, comma separated
+compression = -1 # 100 * algorithm + level, ie. 505 = ZSTD level 5, -1 = ROOT's default
+om_geometry_table = False # True: gamma OM centres from cut_macros/om_geometry.h, gamma_om_y/z never read (check first with om_geometry_check.C)
 simulation_summary_csv = "/sps/nemo/scratch/elvin/csvs/simulation_summary_V2.csv"
 output_csv = "/sps/nemo/scratch/elvin/csvs/real_data_summary_V2.csv" # CHANGE NAME WHEN WORKING WITH ALTERED CUTS - right now its for V1
 detector_vol = 15.4 
 
-def get_metadata(data_filepath):
+def load_metadata():
+    """
+    Load both metadata lists (v1 first, then v2)
+    """
+    df1 = pd.read_csv(metadata_file_1, comment='#', header=None, names=['RUN','RUN_START','DURATION','STOP','COMMENT'], engine='python', sep=r'\s+', usecols=[0,1,2,3,4])
+    df2 = pd.read_csv(metadata_file_2, comment='#', header=None, names=['RUN','RUN_START','DURATION','STOP','COMMENT'], engine='python', sep=r'\s+', usecols=[0,1,2,3,4])
+    return df1, df2
+
+def get_metadata(data_filepath, metadata=None):
     """
     Extract metadata for current datafile (run number, time, duration, phase)
     datafile_path is ".../elvin/data/run_1547.root"
+    metadata is the output of load_metadata(), loaded here if not given
     """
     print("\nExtracting metadata...")
     base_name = os.path.basename(data_filepath)  # ie. "run_1547.root"
@@ -34,8 +54,7 @@ def get_metadata(data_filepath):
     run = int(run_str) # to get just 1547
 
     # Find file in metadata list
-    df1 = pd.read_csv(metadata_file_1, comment='#', header=None, names=['RUN','RUN_START','DURATION','STOP','COMMENT'], engine='python', sep=r'\s+', usecols=[0,1,2,3,4])
-    df2 = pd.read_csv(metadata_file_1, comment='#', header=None, names=['RUN','RUN_START','DURATION','STOP','COMMENT'], engine='python', sep=r'\s+', usecols=[0,1,2,3,4])
+    df1, df2 = metadata if metadata is not None else load_metadata()
     row = df1[df1['RUN'] == run] # check v1 first
     if row.empty:
         row = df2[df2['RUN'] == run] # if not it should be in v2
@@ -61,39 +80,41 @@ def apply_cuts(data_filepath):
     data_filepath is the full file path, ie. sps/nemo/scratch/elvin/data/run_1547.root
     """
     print("\nApplying cuts to root file...")
-    # Get number of events before cuts applied
-    original = uproot.open(data_filepath)
-    original_tree = original["Result_tree"]
-    N_orig = original_tree.num_entries
-    
     # Setup input and output file to cut
     base_name = os.path.basename(data_filepath)
     cut_name = base_name.replace(".root", "_cut.root") # ie. run_1547_cut.root
     output_cut_file = os.path.join(cut_data_directory, cut_name) # full cut file path 
 
     # Apply cuts
-    cmd = ["root", "-l", "-b", "-q", f'{cut_macro}("{data_filepath}", "{output_cut_file}")']
+    cmd = ["root", "-l", "-b", "-q", f'{cut_macro}("{data_filepath}", "{output_cut_file}", true, "{output_mode}", "{slim_branches}", {compression}, {str(om_geometry_table).lower()})']
     result = subprocess.run(cmd, capture_output=True, text=True)
     if result.returncode != 0:
         print(f"\nError running cut macro on {base_name}:\n{result.stderr}")
         raise RuntimeError(f"ROOT macro failed for {base_name}")
     
-    # Get number of events after cuts applied, and cut_file
-    cut = uproot.open(output_cut_file)
-    cut_tree = cut["Result_tree"]
-    N_cut = cut_tree.num_entries
+    # Get number of events before and after cuts applied, straight from the macro
+    counts = parse_counts(result.stdout)
+    N_orig = counts["N_orig"]
+    N_cut = counts["N_cut"]
     print("\nFile cut and new cuts file created!")
     return cut_name, N_orig, N_cut
 
-def calculate_activity(duration, N_orig, N_cut):
+def load_efficiency():
+    """
+    Average efficiency and uncertainty from the simulation summary
+    """
+    df = pd.read_csv(simulation_summary_csv)
+    return df['efficiency'].mean(), df['eff_uncertainty'].mean()
+
+def calculate_activity(duration, N_orig, N_cut, efficiency=None, eff_unc=None):
     """
     Calculate activity from duration and number of events after selection cuts
+    efficiency and eff_unc are read from the simulation summary if not given
     """
     print("\nCalculating Rn activity...")
     # Extract average efficiency calculation
-    df = pd.read_csv(simulation_summary_csv)
-    efficiency = df['efficiency'].mean()
-    eff_unc = df['eff_uncertainty'].mean()
+    if efficiency is None or eff_unc is None:
+        efficiency, eff_unc = load_efficiency()
 
     # Calculate activity in mBq / m^3 and uncertainty
     A = 1000 * N_cut / (duration * detector_vol * efficiency)
@@ -131,6 +152,61 @@ def update_csv(run_number, time, duration, phase, N_orig, N_cut, cut_file, A, A_
         writer.writerows(data_rows)
     print("\ncsv file updated!")
 
+def write_csv(new_rows):
+    """
+    Write a batch of rows to the CSV file in one go, replacing any old entries for the same runs, sorted by run
+    """
+    print(f"\nAdding {len(new_rows)} runs to real_data_summary.csv...")
+    header = ["Run", "midrun_time_Unix", "Duration_s", "Phase", "N_orig", "N_cut", "cut_file", "A_mBq_m-3", "Delta_A"]
+    data_rows = []
+    if os.path.isfile(output_csv):
+        with open(output_csv, "r", newline="") as f:
+            rows = list(csv.reader(f))
+        header = rows[0]
+        new_runs = {str(r[0]) for r in new_rows}
+        data_rows = [r for r in rows[1:] if str(r[0]) not in new_runs] # filter out old entries which have same run name
+    data_rows += [list(r) for r in new_rows]
+    data_rows.sort(key=lambda r: int(r[0]))
+    with open(output_csv, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(header)
+        writer.writerows(data_rows)
+    print("\ncsv file updated!")
+
+def run_batch_pipeline():
+    """
+    Run whole pipeline, with every run cut in one ROOT process by cut_macros/batch_cuts_V2.C
+    """
+    print("\nStarting data pipeline (batch)...")
+
+    # Metadata and efficiency only need loading once
+    metadata = load_metadata()
+    efficiency, eff_unc = load_efficiency()
+
+    # Cut every run (runs which have not changed since last time come straight out of the selection cache)
+    # the counts come back in a csv in the same order as the list
+    data_files = sorted(os.path.join(data_directory, f) for f in os.listdir(data_directory) if f.endswith(".root"))
+    with open(batch_list, "w") as f:
+        f.write("\n".join(data_files) + "\n")
+    cmd = ["root", "-l", "-b", "-q", f'{batch_macro}+("{batch_list}", "{cut_data_directory}", "{batch_counts_csv}", {n_threads}, "{selection_cache_directory}", "{output_mode}", "{slim_branches}", {compression}, {str(om_geometry_table).lower()})']
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    if result.returncode != 0 or not os.path.isfile(batch_counts_csv):
+        print(f"\nError running batch cut macro:\n{result.stderr}")
+        raise RuntimeError("ROOT batch macro failed")
+    counts = pd.read_csv(batch_counts_csv)
+
+    # Work out the activity of every run, then write them all at once
+    rows = []
+    for _, c in counts.iterrows():
+        if not c['ok']:
+            print(f"\nCut macro failed for {c['input_file']}, skipping it")
+            continue
+        run, time, duration, phase = get_metadata(c['input_file'], metadata)
+        A, A_unc = calculate_activity(duration, c['N_orig'], c['N_cut'], efficiency, eff_unc)
+        rows.append([run, time, duration, phase, c['N_orig'], c['N_cut'], c['cut_file'], A, A_unc])
+    write_csv(rows)
+    print("\nPipeline finished!")
+
 def run_pipeline():
     """
     Run whole pipeline from beginning to end
@@ -150,7 +226,7 @@ def run_pipeline():
 
 
 if __name__ == "__main__":
-    run_pipeline()
+    run_batch_pipeline()
     # Make sure it's in the right order
     if os.path.isfile(output_csv):
         df = pd.read_csv(output_csv)
@@ -1,47 +1,49 @@
-# Last edited 30/11/2025
+# Last edited 17/10/2026
 # Author: Anya Elvin
 # Pipeline to run downloaded simulation file(s) through in order to apply cuts, calculate efficiency and append information to a csv
 # csv headings: simulation_file | total_events | selected_events | efficiency | eff_uncertainty
 
 import subprocess
-import uproot
 import csv
 import os
+from cut_counts import parse_counts
 
 # Directories, etc
 original_simulation = "/sps/nemo/scratch/elvin/simulations/Bi214_wire_surface_50M.root" # change to the source foil one when the tracking one is finished
 cut_simulation = "/sps/nemo/scratch/elvin/cut_simulations/Best_V3_cut_Bi214_wire_surface_50M.root"
 original_alias = "Bi214_wire_surface_50M.root"
-cut_macro = "/sps/nemo/scratch/elvin/cut_macros/cuts_V2.C"
+cut_macro = "/sps/nemo/scratch/elvin/cut_macros/parallel_cuts_V2.C" # cuts_V2.C spread over every core, same output as cuts_V2.C
 output_csv = "/sps/nemo/scratch/elvin/csvs/simulation_summary_V3.csv"
+output_mode = "full" # how the survivors are written: "full", "entrylist", "friend" or "slim", see cut_macros/selection_output.h
+slim_branches = "" # branches to keep in "slim" mode, comma separated
+compression = -1 # 100 * algorithm + level, ie. 505 = ZSTD level 5, -1 = ROOT's default
+om_geometry_table = False # True: gamma OM centres from cut_macros/om_geometry.h, gamma_om_y/z never read (check first with om_geometry_check.C)
+n_threads = 0 # 0 = one thread per core, the counts (and so the efficiency) are the same whatever this is
 
 def apply_cuts():
     """
     Runs macro which cuts data based on 1e1gamma channel criteria
     This macro creates output cut file
+    Returns the number of events surviving the cuts
     """
     print("\nApplying cuts to root file...")
 
     # Run cuts macro 
-    cmd = ["root", "-l", "-b", "-q", f'{cut_macro}("{original_simulation}", "{cut_simulation}")']
+    cmd = ["root", "-l", "-b", "-q", f'{cut_macro}+("{original_simulation}", "{cut_simulation}", {n_threads}, "{output_mode}", "{slim_branches}", {compression}, {str(om_geometry_table).lower()})']
     result = subprocess.run(cmd, capture_output=True, text=True)
     if result.returncode != 0:
         print("Error running cuts_V1.C")
         print(result.stderr)
         raise RuntimeError("Cuts macro failed")
     print("\nFile cut and new cuts file created!")
+    return parse_counts(result.stdout)["N_cut"]
 
-def calculate_efficiency_parameters():
+def calculate_efficiency_parameters(n_cut_events):
     """
     Gets total_events, selected_events, efficiency and efficiency uncertainty
     """
-    print("\nOpening filtered simulation file...")
-
-    # Get number of events before and after cuts 
+    # Get number of events before and after cuts (n_cut_events comes from the cut macro)
     n_original_events = 100000000 # Originally 100M events in the simulation file before any 
-    cut_file = uproot.open(cut_simulation) # after
-    cut_tree = cut_file["Result_tree"]
-    n_cut_events = cut_tree.num_entries
     
     # Calculate efficiency and uncertainty
     efficiency = n_cut_events / n_original_events 
@@ -80,8 +82,8 @@ def update_csv(sim_alias, total, selected, efficiency, eff_uncertainty):
 
 def run_pipeline():
     print("\n Starting simulation pipeline")
-    apply_cuts()
-    total, selected, efficiency, eff_uncertainty = calculate_efficiency_parameters()
+    n_cut_events = apply_cuts()
+    total, selected, efficiency, eff_uncertainty = calculate_efficiency_parameters(n_cut_events)
     update_csv(original_alias, total, selected, efficiency, eff_uncertainty)
     print("\nPipeline finished successfully!\n")
 
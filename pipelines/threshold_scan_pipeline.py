@@ -0,0 +1,81 @@
+# Last edited 17/10/2026
+# Author: Anya Elvin
+# Pipeline to scan a grid of cut thresholds over the simulation and all the data in one go each
+# Produces the signal efficiency vs data rate surface, one row per grid point
+# csv headings: point | t_threshold | min_E | max_E_tot | x_foil_buffer | x_calo_buffer | y_buffer | efficiency | eff_uncertainty | N_cut_data | data_rate_Hz | data_rate_uncertainty
+# Before running this code, do "module load root" in the terminal window below
+
+import subprocess
+import os
+import pandas as pd
+
+# Paths to files and constants
+original_simulation = "/sps/nemo/scratch/elvin/simulations/Bi214_wire_surface_50M.root"
+n_original_events = 100000000 # Originally 100M events in the simulation file before any
+data_directory = "/sps/nemo/scratch/elvin/data"
+metadata_file_1 = "/sps/nemo/scratch/elvin/metadata_lists/UDD_betabeta_v1.list"
+metadata_file_2 = "/sps/nemo/scratch/elvin/metadata_lists/UDD_betabeta_v2.list"
+scan_macro = "/sps/nemo/scratch/elvin/cut_macros/threshold_scan.C"
+scan_directory = "/sps/nemo/scratch/elvin/csvs/threshold_scan"
+output_csv = "/sps/nemo/scratch/elvin/csvs/threshold_scan_surface.csv"
+
+# Grid to scan, see cut_macros/threshold_scan.C for the format
+grid_spec = "t_threshold=0.02:0.08:13;min_E=0.05,0.1,0.15;max_E_tot=2.5:3.5:5"
+
+def run_scan(input_files, output_scan_csv, n_original=-1):
+    """
+    Run the scan macro once over input_files (a root file, or a .list of root files)
+    """
+    print(f"\nScanning {input_files}...")
+    cmd = ["root", "-l", "-b", "-q", f'{scan_macro}+("{input_files}", "{grid_spec}", "{output_scan_csv}", {n_original})']
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    if result.returncode != 0 or not os.path.isfile(output_scan_csv):
+        print(f"\nError running scan macro on {input_files}:\n{result.stderr}")
+        raise RuntimeError("Scan macro failed")
+    print("\nScan finished!")
+    return pd.read_csv(output_scan_csv)
+
+def get_total_duration(data_files):
+    """
+    Add up the durations of all the data runs, from the metadata lists
+    """
+    names = ['RUN','RUN_START','DURATION','STOP','COMMENT']
+    df1 = pd.read_csv(metadata_file_1, comment='#', header=None, names=names, engine='python', sep=r'\s+', usecols=[0,1,2,3,4])
+    df2 = pd.read_csv(metadata_file_2, comment='#', header=None, names=names, engine='python', sep=r'\s+', usecols=[0,1,2,3,4])
+    durations = pd.concat([df1, df2]).drop_duplicates(subset='RUN').set_index('RUN')['DURATION']
+    total = 0.0
+    for data_filepath in data_files:
+        run = int("".join([c for c in os.path.basename(data_filepath) if c.isdigit()]))
+        if run not in durations.index:
+            raise ValueError(f"Run {run} not found in metadata files!")
+        total += float(durations[run])
+    return total
+
+def run_pipeline():
+    print("\nStarting threshold scan pipeline...")
+    os.makedirs(scan_directory, exist_ok=True)
+
+    # Simulation: efficiency at every grid point
+    sim = run_scan(original_simulation, os.path.join(scan_directory, "scan_simulation.csv"), n_original_events)
+
+    # Data: every run chained into one job, surviving events at every grid point
+    data_files = sorted(os.path.join(data_directory, f) for f in os.listdir(data_directory) if f.endswith(".root"))
+    data_list = os.path.join(scan_directory, "data_files.list")
+    with open(data_list, "w") as f:
+        f.write("\n".join(data_files) + "\n")
+    data = run_scan(data_list, os.path.join(scan_directory, "scan_data.csv"))
+    duration = get_total_duration(data_files)
+
+    # Combine into the surface
+    params = ["point", "t_threshold", "min_E", "max_E_tot", "x_foil_buffer", "x_calo_buffer", "y_buffer"]
+    surface = sim[params + ["efficiency", "eff_uncertainty"]].copy()
+    surface["N_cut_data"] = data["pass_cut6"].values
+    surface["data_rate_Hz"] = surface["N_cut_data"] / duration
+    surface["data_rate_uncertainty"] = surface["N_cut_data"] ** 0.5 / duration
+    surface.to_csv(output_csv, index=False)
+    print(f"\nSaved efficiency vs data rate surface ({len(surface)} grid points) to {output_csv}")
+    print("\nPipeline finished!")
+
+
+if __name__ == "__main__":
+    run_pipeline()